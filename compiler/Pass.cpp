@@ -14,10 +14,12 @@
 
 #include "Pass.h"
 
+#include <cstdlib>
 #include <llvm/ADT/SmallVector.h>
 #include <llvm/CodeGen/IntrinsicLowering.h>
 #include <llvm/CodeGen/TargetLowering.h>
 #include <llvm/CodeGen/TargetSubtargetInfo.h>
+#include <llvm/IR/IRBuilder.h>
 #include <llvm/IR/InstIterator.h>
 #include <llvm/IR/Module.h>
 #include <llvm/IR/Verifier.h>
@@ -50,6 +52,48 @@ char SymbolizeLegacyPass::ID = 0;
 namespace {
 
 static constexpr char kSymCtorName[] = "__sym_ctor";
+static constexpr char kTrackingPauseName[] = "symcc_tracking_pause";
+static constexpr char kTrackingResumeName[] = "symcc_tracking_resume";
+
+/// Provide definitions for the functions that pause and resume symbolic
+/// tracking, if the program uses them.
+///
+/// The functions just count the active pauses in the process-wide variable that
+/// instrumented code checks before loading expressions, so we can define them
+/// right here instead of calling into the run-time library. Counting makes
+/// pauses nest: tracking resumes only when every pause has been matched by a
+/// call to resume (and excess calls to resume are ignored).
+void defineTrackingControl(Module &M) {
+  auto *counter = getOrCreateTrackingFlag(M);
+
+  for (auto [name, pause] : {std::make_pair(kTrackingPauseName, true),
+                             std::make_pair(kTrackingResumeName, false)}) {
+    auto *function = M.getFunction(name);
+    if (function == nullptr || !function->isDeclaration() ||
+        !function->getReturnType()->isVoidTy() || !function->arg_empty())
+      continue;
+
+    // The optimizer runs before we insert the code that reads the counter. If
+    // it inlined the functions, it would see a store to an unrelated variable
+    // and happily move loads of program data across it (or drop it
+    // altogether). As opaque calls, the functions keep separating the paused
+    // region from the rest of the code.
+    function->setLinkage(GlobalValue::LinkOnceODRLinkage);
+    function->addFnAttr(Attribute::NoInline);
+    function->addFnAttr(Attribute::NoUnwind);
+    IRBuilder<> IRB(BasicBlock::Create(M.getContext(), "", function));
+    auto *pauses = IRB.CreateLoad(IRB.getInt32Ty(), counter);
+    if (pause) {
+      IRB.CreateStore(IRB.CreateAdd(pauses, IRB.getInt32(1)), counter);
+    } else {
+      auto *remaining = IRB.CreateSelect(
+          IRB.CreateICmpEQ(pauses, IRB.getInt32(0)), IRB.getInt32(0),
+          IRB.CreateSub(pauses, IRB.getInt32(1)));
+      IRB.CreateStore(remaining, counter);
+    }
+    IRB.CreateRetVoid();
+  }
+}
 
 bool instrumentModule(Module &M) {
   DEBUG(errs() << "Symbolizer module instrumentation\n");
@@ -62,6 +106,8 @@ bool instrumentModule(Module &M) {
       function.setName(name + "_symbolized");
   }
 
+  defineTrackingControl(M);
+
   // Insert a constructor that initializes the runtime and any globals.
   Function *ctor;
   std::tie(ctor, std::ignore) = createSanitizerCtorAndInitFunctions(
@@ -158,14 +204,89 @@ void liftInlineAssembly(CallInst *CI) {
   targetLowering->ExpandInlineAsm(CI);
 }
 
+/// Decide whether to summarize the path constraints of scanning loops (see
+/// Symbolizer::prepareLoopSummaries).
+bool shouldSummarizeLoops() {
+  static const bool summarizeLoops = [] {
+    const char *setting = std::getenv("SYMCC_SUMMARIZE_LOOPS");
+    return setting != nullptr && StringRef(setting) == "1";
+  }();
+  return summarizeLoops;
+}
+
+/// Redirect calls to functions with optional symbolic models, as well as to
+/// functions that the user has summarized.
+///
+/// Unlike the wrappers for intercepted functions, the models may be missing
+/// from the run-time library in use, so we can't simply rename the callee.
+/// Instead, we declare each model as a weak symbol and select it at the call
+/// site if it's defined; otherwise, the call goes to the original function as
+/// before, and its result is concrete. User-provided summaries are handled the
+/// same way, except that the summarized function may be defined in the module.
+/// (We don't instrument models and summaries that the program defines, so calls
+/// from the model itself keep going to the original function; see
+/// isModelDefinition.)
+///
+/// Since the indirect call hides the callee from the optimizer, we only
+/// redirect the calls that remain after optimization.
+void redirectToModels(Function &F) {
+  auto &M = *F.getParent();
+
+  SmallVector<CallBase *, 8> calls;
+  for (auto &I : instructions(F)) {
+    auto *call = dyn_cast<CallBase>(&I);
+    if (call == nullptr)
+      continue;
+
+    auto *callee = call->getCalledFunction();
+    if (callee != nullptr &&
+        ((callee->isDeclaration() && isModeledFunction(callee->getName())) ||
+         isSummarizedFunction(callee->getName())))
+      calls.push_back(call);
+  }
+
+  for (auto *call : calls) {
+    auto *function = call->getCalledFunction();
+    auto modelName = (function->getName() + "_symbolized").str();
+    auto *model = M.getFunction(modelName);
+    if (model == nullptr)
+      model = Function::Create(function->getFunctionType(),
+                               GlobalValue::ExternalWeakLinkage, modelName, &M);
+    else if (model->getFunctionType() != function->getFunctionType())
+      continue;
+
+    IRBuilder<> IRB(call);
+    auto *haveModel =
+        IRB.CreateICmpNE(model, ConstantPointerNull::get(model->getType()));
+    call->setCalledOperand(IRB.CreateSelect(haveModel, model, function));
+  }
+}
+
+/// Decide whether a function is a model or summary that the program defines
+/// itself (see redirectToModels).
+///
+/// Models and summaries manage symbolic expressions explicitly via the
+/// run-time library's API. If we instrumented them, they would receive null
+/// expressions for their own calls to _sym_get_parameter_expression, and the
+/// instrumentation of their return would overwrite the expression that they
+/// publish with _sym_set_return_expression.
+bool isModelDefinition(StringRef functionName) {
+  return functionName.consume_back("_symbolized") &&
+         (isModeledFunction(functionName) ||
+          isSummarizedFunction(functionName));
+}
+
 bool instrumentFunction(Function &F) {
   auto functionName = F.getName();
-  if (functionName == kSymCtorName)
+  if (functionName == kSymCtorName || functionName == kTrackingPauseName ||
+      functionName == kTrackingResumeName || isModelDefinition(functionName))
     return false;
 
   DEBUG(errs() << "Symbolizing function ");
   DEBUG(errs().write_escaped(functionName) << '\n');
 
+  redirectToModels(F);
+
   SmallVector<Instruction *, 0> allInstructions;
   allInstructions.reserve(F.getInstructionCount());
   for (auto &I : instructions(F))
@@ -182,11 +303,14 @@ bool instrumentFunction(Function &F) {
     }
   }
 
+  Symbolizer symbolizer(*F.getParent());
+  if (shouldSummarizeLoops())
+    symbolizer.prepareLoopSummaries(F);
+
   allInstructions.clear();
   for (auto &I : instructions(F))
     allInstructions.push_back(&I);
 
-  Symbolizer symbolizer(*F.getParent());
   symbolizer.symbolizeFunctionArguments(F);
 
   for (auto &basicBlock : F)
@@ -195,6 +319,7 @@ bool instrumentFunction(Function &F) {
   for (auto *instPtr : allInstructions)
     symbolizer.visit(instPtr);
 
+  symbolizer.finalizeLoopSummaries();
   symbolizer.finalizePHINodes();
   symbolizer.shortCircuitExpressionUses();
 
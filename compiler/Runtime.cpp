@@ -14,9 +14,13 @@
 
 #include "Runtime.h"
 
+#include <cstdlib>
+#include <llvm/ADT/SmallVector.h>
 #include <llvm/ADT/StringSet.h>
 #include <llvm/Config/llvm-config.h>
 #include <llvm/IR/IRBuilder.h>
+#include <llvm/Support/ErrorHandling.h>
+#include <llvm/Support/MemoryBuffer.h>
 
 using namespace llvm;
 
@@ -187,6 +191,8 @@ Runtime::Runtime(Module &M) {
   notifyCall = import(M, "_sym_notify_call", voidT, intPtrType);
   notifyRet = import(M, "_sym_notify_ret", voidT, intPtrType);
   notifyBasicBlock = import(M, "_sym_notify_basic_block", voidT, intPtrType);
+
+  trackingPaused = getOrCreateTrackingFlag(M);
 }
 
 /// Decide whether a function is called symbolically.
@@ -200,3 +206,65 @@ bool isInterceptedFunction(const Function &f) {
 
   return (kInterceptedFunctions.count(f.getName()) > 0);
 }
+
+/// Decide whether a function has an optional symbolic model.
+bool isModeledFunction(StringRef name) {
+  // glibc's headers may replace sscanf and the strto* functions with variants
+  // that implement a particular version of the C standard (e.g.,
+  // __isoc99_sscanf), so we list those variants as well.
+  static const StringSet<> kModeledFunctions = {
+      "strcmp",          "strncmp",          "strlen",
+      "strnlen",         "memchr",           "strstr",
+      "strtol",          "strtoul",          "strtoll",
+      "strtoull",        "atoi",             "atol",
+      "sscanf",          "__isoc99_sscanf",  "__isoc23_sscanf",
+      "__isoc23_strtol", "__isoc23_strtoul", "__isoc23_strtoll",
+      "__isoc23_strtoull"};
+
+  return (kModeledFunctions.count(name) > 0);
+}
+
+/// Decide whether the user has provided a summary for a function.
+///
+/// The environment variable SYMCC_FUNCTION_SUMMARIES may name a file that
+/// lists one function per line; everything after a "#" is a comment.
+bool isSummarizedFunction(StringRef name) {
+  static const StringSet<> kSummarizedFunctions = [] {
+    StringSet<> functions;
+    const char *path = std::getenv("SYMCC_FUNCTION_SUMMARIES");
+    if (path == nullptr)
+      return functions;
+
+    auto buffer = MemoryBuffer::getFile(path);
+    if (!buffer)
+      report_fatal_error(Twine("Failed to read the function summaries from ") +
+                             path + ": " + buffer.getError().message(),
+                         /* gen_crash_diag */ false);
+
+    SmallVector<StringRef, 32> lines;
+    (*buffer)->getBuffer().split(lines, '\n');
+    for (auto line : lines) {
+      auto name = line.split('#').first.trim();
+      if (!name.empty())
+        functions.insert(name);
+    }
+
+    return functions;
+  }();
+
+  return (kSummarizedFunctions.count(name) > 0);
+}
+
+GlobalVariable *getOrCreateTrackingFlag(Module &M) {
+  // The counter is defined in every instrumented module; since its linkage is
+  // linkonce_odr, the linker merges all definitions into a single variable for
+  // the entire process.
+  auto *int32T = Type::getInt32Ty(M.getContext());
+  return cast<GlobalVariable>(
+      M.getOrInsertGlobal("_sym_tracking_paused", int32T, [&] {
+        return new GlobalVariable(M, int32T, false,
+                                  GlobalValue::LinkOnceODRLinkage,
+                                  ConstantInt::get(int32T, 0),
+                                  "_sym_tracking_paused");
+      }));
+}
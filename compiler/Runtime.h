@@ -15,6 +15,7 @@
 #ifndef RUNTIME_H
 #define RUNTIME_H
 
+#include <llvm/IR/GlobalVariable.h>
 #include <llvm/IR/InstrTypes.h>
 #include <llvm/IR/Module.h>
 
@@ -81,6 +82,10 @@ struct Runtime {
   SymFnT notifyRet{};
   SymFnT notifyBasicBlock{};
 
+  /// The number of active pauses of symbolic tracking (i.e., tracking is paused
+  /// if it's non-zero).
+  llvm::GlobalVariable *trackingPaused{};
+
   /// Mapping from icmp predicates to the functions that build the corresponding
   /// symbolic expressions.
   std::array<SymFnT, llvm::CmpInst::BAD_ICMP_PREDICATE> comparisonHandlers{};
@@ -96,4 +101,16 @@ struct Runtime {
 
 bool isInterceptedFunction(const llvm::Function &f);
 
+/// Decide whether calls to a function should go to its symbolic model (i.e.,
+/// "<name>_symbolized") if the run-time library provides one.
+bool isModeledFunction(llvm::StringRef name);
+
+/// Decide whether calls to a function should go to a summary (i.e.,
+/// "<name>_symbolized") that the user provides along with the program.
+bool isSummarizedFunction(llvm::StringRef name);
+
+/// Get the process-wide counter of active pauses of symbolic tracking,
+/// defining it in M if necessary.
+llvm::GlobalVariable *getOrCreateTrackingFlag(llvm::Module &M);
+
 #endif
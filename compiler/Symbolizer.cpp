@@ -16,8 +16,11 @@
 
 #include <cstdint>
 #include <llvm/ADT/SmallPtrSet.h>
+#include <llvm/Analysis/LoopInfo.h>
 #include <llvm/IR/Constants.h>
+#include <llvm/IR/Dominators.h>
 #include <llvm/IR/GetElementPtrTypeIterator.h>
+#include <llvm/IR/IntrinsicInst.h>
 #include <llvm/IR/Intrinsics.h>
 #include <llvm/Transforms/Utils/BasicBlockUtils.h>
 
@@ -25,6 +28,143 @@
 
 using namespace llvm;
 
+namespace {
+
+/// Decide whether V is a byte that the loop loads from memory (possibly
+/// extended to a larger integer type).
+bool isScannedByte(Value *V, const Loop &L) {
+  if (auto *ext = dyn_cast<ZExtInst>(V))
+    V = ext->getOperand(0);
+  else if (auto *ext = dyn_cast<SExtInst>(V))
+    V = ext->getOperand(0);
+
+  auto *load = dyn_cast<LoadInst>(V);
+  return load != nullptr && load->getType()->isIntegerTy(8) &&
+         L.contains(load);
+}
+
+/// Return the value that the PHI node in the loop header takes in the next
+/// iteration if it is the result of advancing the PHI by a constant; otherwise,
+/// return null.
+Value *getInductionStep(PHINode &phi, const Loop &L) {
+  auto *next = phi.getIncomingValueForBlock(L.getLoopLatch());
+
+  if (auto *gep = dyn_cast<GetElementPtrInst>(next)) {
+    if (gep->getPointerOperand() == &phi && gep->getNumIndices() == 1 &&
+        isa<ConstantInt>(*gep->idx_begin()))
+      return gep;
+  } else if (auto *binOp = dyn_cast<BinaryOperator>(next)) {
+    if ((binOp->getOpcode() == Instruction::Add ||
+         binOp->getOpcode() == Instruction::Sub) &&
+        binOp->getOperand(0) == &phi && isa<ConstantInt>(binOp->getOperand(1)))
+      return binOp;
+  }
+
+  return nullptr;
+}
+
+/// Decide whether V is an induction variable of the loop or its value in the
+/// next iteration.
+bool isInductionValue(Value *V, const Loop &L) {
+  for (auto &phi : L.getHeader()->phis()) {
+    auto *step = getInductionStep(phi, L);
+    if (step != nullptr && (V == &phi || V == step))
+      return true;
+  }
+
+  return false;
+}
+
+/// The kinds of conditions that can decide whether to leave a scanning loop.
+enum class ExitCondition {
+  Unsupported,
+  /// A comparison of a scanned byte with a loop-invariant value
+  ByteComparison,
+  /// A comparison of an induction variable with a loop-invariant value
+  BoundCheck
+};
+
+/// Classify the condition of a branch that may leave the loop.
+ExitCondition classifyExitCondition(const BranchInst &branch, const Loop &L) {
+  if (branch.isUnconditional() ||
+      L.contains(branch.getSuccessor(0)) == L.contains(branch.getSuccessor(1)))
+    return ExitCondition::Unsupported;
+
+  auto *comparison = dyn_cast<ICmpInst>(branch.getCondition());
+  if (comparison == nullptr || !L.contains(comparison))
+    return ExitCondition::Unsupported;
+
+  for (unsigned i = 0; i < 2; i++) {
+    auto *operand = comparison->getOperand(i);
+    if (!L.isLoopInvariant(comparison->getOperand(1 - i)))
+      continue;
+    if (isScannedByte(operand, L))
+      return ExitCondition::ByteComparison;
+    if (isInductionValue(operand, L))
+      return ExitCondition::BoundCheck;
+  }
+
+  return ExitCondition::Unsupported;
+}
+
+/// Determine whether an instruction is an intrinsic call that only carries
+/// information for the optimizer or the debugger.
+///
+/// Such calls don't produce path constraints, so they mustn't prevent loop
+/// summaries (e.g., in builds with debug information).
+bool isAnnotationIntrinsic(const Instruction &I) {
+  if (isa<DbgInfoIntrinsic>(I))
+    return true;
+
+  auto *intrinsic = dyn_cast<IntrinsicInst>(&I);
+  if (intrinsic == nullptr)
+    return false;
+
+  auto id = intrinsic->getIntrinsicID();
+  return id == Intrinsic::lifetime_start || id == Intrinsic::lifetime_end ||
+         id == Intrinsic::assume ||
+#if LLVM_VERSION_MAJOR > 11
+         id == Intrinsic::experimental_noalias_scope_decl ||
+#endif
+         id == Intrinsic::invariant_start || id == Intrinsic::invariant_end;
+}
+
+/// Decide whether we can summarize the path constraints of the loop.
+///
+/// We only consider innermost loops with a single entry edge whose control flow
+/// depends exclusively on comparisons of scanned bytes and bound checks on
+/// induction variables. Since calls, selects and switches may produce path
+/// constraints of their own, we reject loops that contain any of them (except
+/// for annotation intrinsics).
+bool isScanningLoop(const Loop &L) {
+  if (!L.getSubLoops().empty() || L.getLoopPredecessor() == nullptr ||
+      L.getLoopLatch() == nullptr)
+    return false;
+
+  bool haveByteComparison = false;
+  for (auto *block : L.blocks()) {
+    for (auto &I : *block) {
+      if ((isa<CallBase>(I) && !isAnnotationIntrinsic(I)) ||
+          isa<SelectInst>(I) || isa<SwitchInst>(I) || isa<IndirectBrInst>(I))
+        return false;
+
+      auto *branch = dyn_cast<BranchInst>(&I);
+      if (branch == nullptr || branch->isUnconditional())
+        continue;
+
+      auto condition = classifyExitCondition(*branch, L);
+      if (condition == ExitCondition::Unsupported)
+        return false;
+      if (condition == ExitCondition::ByteComparison)
+        haveByteComparison = true;
+    }
+  }
+
+  return haveByteComparison;
+}
+
+} // namespace
+
 void Symbolizer::symbolizeFunctionArguments(Function &F) {
   // The main function doesn't receive symbolic arguments.
   if (F.getName() == "main")
@@ -34,16 +174,139 @@ void Symbolizer::symbolizeFunctionArguments(Function &F) {
 
   for (auto &arg : F.args()) {
     if (!arg.user_empty())
-      symbolicExpressions[&arg] = IRB.CreateCall(runtime.getParameterExpression,
-                                                 IRB.getInt8(arg.getArgNo()));
+      symbolicExpressions[&arg] = maskIfTrackingPaused(
+          IRB, IRB.CreateCall(runtime.getParameterExpression,
+                              IRB.getInt8(arg.getArgNo())));
   }
 }
 
+Value *Symbolizer::isTrackingPaused(IRBuilder<> &IRB) {
+  return IRB.CreateICmpNE(
+      IRB.CreateLoad(IRB.getInt32Ty(), runtime.trackingPaused),
+      IRB.getInt32(0));
+}
+
+Value *Symbolizer::maskIfTrackingPaused(IRBuilder<> &IRB, Value *expr) {
+  return IRB.CreateSelect(
+      isTrackingPaused(IRB),
+      ConstantPointerNull::get(IRB.getInt8Ty()->getPointerTo()), expr);
+}
+
+void Symbolizer::maskPathConstraint(Value *pushConstraint) {
+  // The run-time library ignores null constraints. We insert the mask before
+  // the call, so that the short-circuiting logic sees the masked expression
+  // and skips the call altogether while tracking is paused.
+  auto *call = cast<CallInst>(pushConstraint);
+  IRBuilder<> IRB(call);
+  call->setArgOperand(0, maskIfTrackingPaused(IRB, call->getArgOperand(0)));
+}
+
+void Symbolizer::copyShadowUnlessPaused(Instruction &I, SymFnT copyFunction,
+                                        Value *dest, Value *src,
+                                        Value *length) {
+  IRBuilder<> IRB(&I);
+  Instruction *pausedTerm, *trackingTerm;
+  SplitBlockAndInsertIfThenElse(isTrackingPaused(IRB), &I, &pausedTerm,
+                                &trackingTerm);
+
+  IRB.SetInsertPoint(pausedTerm);
+  auto *nullExpression =
+      ConstantPointerNull::get(IRB.getInt8Ty()->getPointerTo());
+  IRB.CreateCall(runtime.memset, {dest, nullExpression, length});
+  IRB.SetInsertPoint(trackingTerm);
+  IRB.CreateCall(copyFunction, {dest, src, length});
+}
+
 void Symbolizer::insertBasicBlockNotification(llvm::BasicBlock &B) {
   IRBuilder<> IRB(&*B.getFirstInsertionPt());
   IRB.CreateCall(runtime.notifyBasicBlock, getTargetPreferredInt(&B));
 }
 
+void Symbolizer::prepareLoopSummaries(Function &F) {
+  DominatorTree DT(F);
+  LoopInfo LI(DT);
+
+  // Record the exiting branches along with their exit blocks; we only split
+  // the exit edges after analyzing all loops, so that we don't invalidate the
+  // loop information while we still need it.
+  std::vector<std::pair<LoopSummary, BasicBlock *>> candidates;
+  for (auto *L : LI.getLoopsInPreorder()) {
+    if (!isScanningLoop(*L))
+      continue;
+
+    LoopSummary summary{nullptr, L->getLoopPredecessor(), {}};
+    for (auto *block : L->blocks()) {
+      auto *branch = dyn_cast<BranchInst>(block->getTerminator());
+      if (branch == nullptr || branch->isUnconditional())
+        continue;
+
+      auto *exit = branch->getSuccessor(L->contains(branch->getSuccessor(0)));
+      summary.exits.emplace_back(branch, exit);
+    }
+    candidates.emplace_back(std::move(summary), L->getHeader());
+  }
+
+  for (auto &[summary, header] : candidates) {
+    // Late in the optimization pipeline, the block that enters the loop may
+    // branch elsewhere as well; we need an edge of our own to reset the
+    // accumulator.
+    if (summary.preheader->getSingleSuccessor() == nullptr) {
+      summary.preheader = SplitCriticalEdge(summary.preheader, header);
+      if (summary.preheader == nullptr)
+        continue;
+    }
+
+    // Similarly, we need a place to push the summary that is only reached when
+    // leaving the loop via the respective branch.
+    bool haveExitBlocks = true;
+    for (auto &[branch, exitBlock] : summary.exits) {
+      if (exitBlock->getSinglePredecessor() != nullptr)
+        continue;
+
+      exitBlock = SplitCriticalEdge(branch, branch->getSuccessor(0) == exitBlock
+                                                ? 0
+                                                : 1);
+      if (exitBlock == nullptr) {
+        haveExitBlocks = false;
+        break;
+      }
+    }
+    if (!haveExitBlocks)
+      continue;
+
+    summary.accumulator =
+        new AllocaInst(Type::getInt8Ty(F.getContext())->getPointerTo(),
+                       dataLayout.getAllocaAddrSpace(), "",
+                       &*F.getEntryBlock().getFirstInsertionPt());
+    for (auto &[branch, exitBlock] : summary.exits)
+      summarizedBranches[branch] = summary.accumulator;
+    loopSummaries.push_back(std::move(summary));
+  }
+}
+
+void Symbolizer::finalizeLoopSummaries() {
+  auto *nullExpression = ConstantPointerNull::get(
+      Type::getInt8Ty(intPtrType->getContext())->getPointerTo());
+
+  for (auto &summary : loopSummaries) {
+    IRBuilder<> IRB(summary.preheader->getTerminator());
+    IRB.CreateStore(nullExpression, summary.accumulator);
+
+    for (auto &[branch, exitBlock] : summary.exits) {
+      IRB.SetInsertPoint(&*exitBlock->getFirstInsertionPt());
+      auto *conjunction = maskIfTrackingPaused(
+          IRB, IRB.CreateLoad(IRB.getInt8Ty()->getPointerTo(),
+                              summary.accumulator));
+      auto *pushConstraint = IRB.CreateCall(
+          runtime.pushPathConstraint,
+          {conjunction, IRB.getInt1(true), getTargetPreferredInt(branch)});
+      registerSymbolicComputation(SymbolicComputation(
+          pushConstraint, pushConstraint,
+          {Input(IRB.getTrue(), 0, pushConstraint)}));
+    }
+  }
+}
+
 void Symbolizer::finalizePHINodes() {
   SmallPtrSet<PHINode *, 32> nodesToErase;
 
@@ -198,9 +461,8 @@ void Symbolizer::handleIntrinsicCall(CallBase &I) {
     // 32-bit architectures. However, what's the point of specifying a length to
     // memcpy that is larger than your address space?
 
-    IRB.CreateCall(runtime.memcpy,
-                   {I.getOperand(0), I.getOperand(1),
-                    IRB.CreateZExtOrTrunc(I.getOperand(2), intPtrType)});
+    copyShadowUnlessPaused(I, runtime.memcpy, I.getOperand(0), I.getOperand(1),
+                           IRB.CreateZExtOrTrunc(I.getOperand(2), intPtrType));
     break;
   }
   case Intrinsic::memset: {
@@ -211,9 +473,10 @@ void Symbolizer::handleIntrinsicCall(CallBase &I) {
 
     // The comment on memcpy's length parameter applies analogously.
 
+    auto *valueExpr =
+        maskIfTrackingPaused(IRB, getSymbolicExpressionOrNull(I.getOperand(1)));
     IRB.CreateCall(runtime.memset,
-                   {I.getOperand(0),
-                    getSymbolicExpressionOrNull(I.getOperand(1)),
+                   {I.getOperand(0), valueExpr,
                     IRB.CreateZExtOrTrunc(I.getOperand(2), intPtrType)});
     break;
   }
@@ -226,9 +489,9 @@ void Symbolizer::handleIntrinsicCall(CallBase &I) {
 
     // The comment on memcpy's length parameter applies analogously.
 
-    IRB.CreateCall(runtime.memmove,
-                   {I.getOperand(0), I.getOperand(1),
-                    IRB.CreateZExtOrTrunc(I.getOperand(2), intPtrType)});
+    copyShadowUnlessPaused(I, runtime.memmove, I.getOperand(0),
+                           I.getOperand(1),
+                           IRB.CreateZExtOrTrunc(I.getOperand(2), intPtrType));
     break;
   }
   case Intrinsic::stacksave: {
@@ -390,7 +653,8 @@ void Symbolizer::handleFunctionCall(CallBase &I, Instruction *returnPoint) {
     IRB.CreateCall(runtime.setReturnExpression,
                    ConstantPointerNull::get(IRB.getInt8Ty()->getPointerTo()));
     IRB.SetInsertPoint(returnPoint);
-    symbolicExpressions[&I] = IRB.CreateCall(runtime.getReturnExpression);
+    symbolicExpressions[&I] =
+        maskIfTrackingPaused(IRB, IRB.CreateCall(runtime.getReturnExpression));
   }
 }
 
@@ -445,6 +709,8 @@ void Symbolizer::visitSelectInst(SelectInst &I) {
                                       {{I.getCondition(), true},
                                        {I.getCondition(), false},
                                        {getTargetPreferredInt(&I), false}});
+  if (runtimeCall)
+    maskPathConstraint(runtimeCall->lastInstruction);
   registerSymbolicComputation(runtimeCall);
   if (getSymbolicExpression(I.getTrueValue()) ||
       getSymbolicExpression(I.getFalseValue())) {
@@ -491,10 +757,43 @@ void Symbolizer::visitBranchInst(BranchInst &I) {
     return;
 
   IRBuilder<> IRB(&I);
+
+  auto summary = summarizedBranches.find(&I);
+  if (summary != summarizedBranches.end()) {
+    // The branch belongs to a loop whose constraints we summarize (see
+    // prepareLoopSummaries). Instead of pushing the condition, we add it to
+    // the conjunction; we negate it if the branch isn't taken by XOR-ing with
+    // "true".
+    auto *conditionExpr = getSymbolicExpression(I.getCondition());
+    if (conditionExpr == nullptr)
+      return;
+
+    auto *accumulator = summary->second;
+    auto *previous =
+        IRB.CreateLoad(IRB.getInt8Ty()->getPointerTo(), accumulator);
+    auto *negation = IRB.CreateCall(runtime.buildBool,
+                                    IRB.CreateNot(I.getCondition()));
+    auto *constraint =
+        IRB.CreateCall(runtime.buildBoolXor, {conditionExpr, negation});
+    auto *conjunction =
+        IRB.CreateCall(runtime.buildBoolAnd, {previous, constraint});
+    IRB.CreateStore(conjunction, accumulator);
+
+    // A null accumulator means that there are no constraints yet, i.e., the
+    // conjunction is "true".
+    registerSymbolicComputation(
+        SymbolicComputation(negation, conjunction,
+                            {Input(I.getCondition(), 0, constraint),
+                             Input(IRB.getTrue(), 0, conjunction)}));
+    return;
+  }
+
   auto runtimeCall = buildRuntimeCall(IRB, runtime.pushPathConstraint,
                                       {{I.getCondition(), true},
                                        {I.getCondition(), false},
                                        {getTargetPreferredInt(&I), false}});
+  if (runtimeCall)
+    maskPathConstraint(runtimeCall->lastInstruction);
   registerSymbolicComputation(runtimeCall);
 }
 
@@ -540,7 +839,8 @@ void Symbolizer::visitLoadInst(LoadInst &I) {
        ConstantInt::get(intPtrType, dataLayout.getTypeStoreSize(dataType)),
        IRB.getInt1(isLittleEndian(dataType) ? 1 : 0)});
 
-  symbolicExpressions[&I] = convertBitVectorExprForType(IRB, data, dataType);
+  symbolicExpressions[&I] = convertBitVectorExprForType(
+      IRB, cast<Instruction>(maskIfTrackingPaused(IRB, data)), dataType);
 }
 
 void Symbolizer::visitStoreInst(StoreInst &I) {
@@ -561,8 +861,9 @@ void Symbolizer::visitStoreInst(StoreInst &I) {
       runtime.writeMemory,
       {IRB.CreatePtrToInt(I.getPointerOperand(), intPtrType),
        ConstantInt::get(intPtrType, dataLayout.getTypeStoreSize(V->getType())),
-       maybeConversion ? maybeConversion->lastInstruction
-                       : getSymbolicExpressionOrNull(V),
+       maskIfTrackingPaused(IRB, maybeConversion
+                                     ? maybeConversion->lastInstruction
+                                     : getSymbolicExpressionOrNull(V)),
        IRB.getInt1(isLittleEndian(V->getType()) ? 1 : 0)});
 }
 
@@ -912,6 +1213,7 @@ void Symbolizer::visitSwitchInst(SwitchInst &I) {
   auto *conditionExpr = getSymbolicExpression(condition);
   if (conditionExpr == nullptr)
     return;
+  conditionExpr = maskIfTrackingPaused(IRB, conditionExpr);
 
   // Build a check whether we have a symbolic condition, to be used later.
   auto *haveSymbolicCondition = IRB.CreateICmpNE(
@@ -1093,6 +1395,7 @@ Symbolizer::SymbolicComputation Symbolizer::forceBuildRuntimeCall(
 void Symbolizer::tryAlternative(IRBuilder<> &IRB, Value *V) {
   auto *destExpr = getSymbolicExpression(V);
   if (destExpr != nullptr) {
+    destExpr = maskIfTrackingPaused(IRB, destExpr);
     auto *concreteDestExpr = createValueExpression(V, IRB);
     auto *destAssertion =
         IRB.CreateCall(runtime.comparisonHandlers[CmpInst::ICMP_EQ],
@@ -15,6 +15,7 @@
 #ifndef SYMBOLIZE_H
 #define SYMBOLIZE_H
 
+#include <llvm/ADT/DenseMap.h>
 #include <llvm/IR/BasicBlock.h>
 #include <llvm/IR/IRBuilder.h>
 #include <llvm/IR/InstVisitor.h>
@@ -38,6 +39,25 @@ public:
   /// entry.
   void insertBasicBlockNotification(llvm::BasicBlock &B);
 
+  /// Find the loops whose path constraints we summarize.
+  ///
+  /// Scanning loops (e.g., in strlen or memchr) compare one byte per
+  /// iteration, and pushing each comparison as a path constraint makes the
+  /// solver generate a near-duplicate test case per iteration. For innermost
+  /// loops that only branch on comparisons of a loaded byte or an induction
+  /// variable with a loop-invariant value, we instead collect the constraints
+  /// of all iterations in a conjunction and push it once on loop exit. This
+  /// function has to be called before any instructions are visited because it
+  /// splits the loops' exit edges.
+  void prepareLoopSummaries(llvm::Function &F);
+
+  /// Emit the code that resets the summaries on loop entry and pushes them on
+  /// loop exit.
+  ///
+  /// This has to be called after all instructions have been visited, but
+  /// before short-circuiting expression uses.
+  void finalizeLoopSummaries();
+
   /// Finish the processing of PHI nodes.
   ///
   /// This assumes that there is a dummy PHI node for each such instruction in
@@ -137,6 +157,19 @@ private:
   static constexpr unsigned kExpectedMaxPHINodesPerFunction = 16;
   static constexpr unsigned kExpectedSymbolicArgumentsPerComputation = 2;
 
+  /// A loop whose path constraints we summarize.
+  struct LoopSummary {
+    /// The stack slot that holds the conjunction of the constraints so far.
+    llvm::AllocaInst *accumulator;
+
+    /// The block that enters the loop.
+    llvm::BasicBlock *preheader;
+
+    /// The exiting branches, along with the blocks on their exit edges.
+    llvm::SmallVector<std::pair<llvm::BranchInst *, llvm::BasicBlock *>, 2>
+        exits;
+  };
+
   /// A symbolic input.
   struct Input {
     llvm::Value *concreteValue;
@@ -304,6 +337,29 @@ private:
                                   reinterpret_cast<uint64_t>(pointer));
   }
 
+  /// Emit a check whether symbolic tracking is currently paused.
+  llvm::Value *isTrackingPaused(llvm::IRBuilder<> &IRB);
+
+  /// Emit code that replaces the expression with null while symbolic tracking
+  /// is paused; return the value that computes the result.
+  ///
+  /// We apply this to all sources of expressions (i.e., memory, parameters and
+  /// return values), so that code running while tracking is paused computes
+  /// only concrete values. Values that were symbolic before the pause are
+  /// masked where they would leave a trace: in path constraints and in stores
+  /// to memory.
+  llvm::Value *maskIfTrackingPaused(llvm::IRBuilder<> &IRB, llvm::Value *expr);
+
+  /// Make a call to _sym_push_path_constraint ineffective while symbolic
+  /// tracking is paused.
+  void maskPathConstraint(llvm::Value *pushConstraint);
+
+  /// Emit a call that copies shadow memory along with a memory transfer, or
+  /// clears the destination's shadow if symbolic tracking is paused.
+  void copyShadowUnlessPaused(llvm::Instruction &I, SymFnT copyFunction,
+                              llvm::Value *dest, llvm::Value *src,
+                              llvm::Value *length);
+
   /// Compute the offset of a member in a (possibly nested) aggregate.
   uint64_t aggregateMemberOffset(llvm::Type *aggregateType,
                                  llvm::ArrayRef<unsigned> indices) const;
@@ -370,6 +426,13 @@ private:
   /// Therefore, we keep a record of all the places that construct expressions
   /// and insert the fast path later.
   std::vector<SymbolicComputation> expressionUses;
+
+  /// The loops whose path constraints we summarize.
+  std::vector<LoopSummary> loopSummaries;
+
+  /// Mapping from the branches in summarized loops to the stack slot that
+  /// accumulates their constraints.
+  llvm::DenseMap<llvm::BranchInst *, llvm::AllocaInst *> summarizedBranches;
 };
 
 #endif
@@ -0,0 +1,48 @@
+// This file is part of SymCC.
+//
+// SymCC is free software: you can redistribute it and/or modify it under the
+// terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or (at your option) any later
+// version.
+//
+// SymCC is distributed in the hope that it will be useful, but WITHOUT ANY
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+// A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// SymCC. If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef SYMCC_TRACKING_H
+#define SYMCC_TRACKING_H
+
+// Control symbolic tracking from the program under test (see
+// docs/Concreteness.txt). The compiler pass defines these functions in every
+// module that uses them.
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// Pause symbolic tracking until the matching call to symcc_tracking_resume.
+///
+/// Pauses nest, so tracking resumes only when every pause has been matched.
+void symcc_tracking_pause(void);
+
+/// Undo the most recent call to symcc_tracking_pause.
+void symcc_tracking_resume(void);
+
+#ifdef __cplusplus
+}
+
+/// Pause symbolic tracking for the lifetime of the object.
+class SymccTrackingPause {
+public:
+  SymccTrackingPause() { symcc_tracking_pause(); }
+  ~SymccTrackingPause() { symcc_tracking_resume(); }
+
+  SymccTrackingPause(const SymccTrackingPause &) = delete;
+  SymccTrackingPause &operator=(const SymccTrackingPause &) = delete;
+};
+#endif
+
+#endif
@@ -0,0 +1,70 @@
+// This file is part of SymCC.
+//
+// SymCC is free software: you can redistribute it and/or modify it under the
+// terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or (at your option) any later
+// version.
+//
+// SymCC is distributed in the hope that it will be useful, but WITHOUT ANY
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+// A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// SymCC. If not, see <https://www.gnu.org/licenses/>.
+
+// RUN: echo "decode # the summarized function" > %t.summaries
+// RUN: env SYMCC_FUNCTION_SUMMARIES=%t.summaries %symcc -O2 %s -o %t
+// RUN: echo -ne "\x05" | %t 2>&1 | %filecheck %s
+//
+// Calls to functions listed in the summary file go to "<name>_symbolized",
+// which isn't instrumented, so that it can publish an expression for the
+// result.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <unistd.h>
+
+typedef void *SymExpr;
+SymExpr _sym_get_parameter_expression(uint8_t index);
+void _sym_set_return_expression(SymExpr expr);
+SymExpr _sym_build_integer(uint64_t value, uint8_t bits);
+SymExpr _sym_build_mul(SymExpr a, SymExpr b);
+
+static int table[256];
+
+// The result depends on the argument only through the table index, so the
+// instrumentation alone can't express it symbolically.
+__attribute__((noinline)) int decode(int x) { return table[x]; }
+
+int decode_symbolized(int x) {
+  SymExpr xExpr = _sym_get_parameter_expression(0);
+  int result = decode(x);
+  _sym_set_return_expression(
+      xExpr == NULL ? NULL
+                    : _sym_build_mul(xExpr, _sym_build_integer(3, 32)));
+  return result;
+}
+
+int main(int argc, char *argv[]) {
+  for (int i = 0; i < 256; i++)
+    table[i] = i * 3;
+
+  uint8_t x;
+  if (read(STDIN_FILENO, &x, sizeof(x)) != sizeof(x)) {
+    fprintf(stderr, "Failed to read the input\n");
+    return -1;
+  }
+
+  int decoded = decode(x);
+  fprintf(stderr, "%d\n", decoded);
+  // ANY: 15
+
+  fprintf(stderr, "%s\n", (decoded == 126) ? "yes" : "no");
+  // SIMPLE: Trying to solve
+  // SIMPLE: Found diverging input
+  // SIMPLE: stdin0 -> #x2a
+  // QSYM: SMT
+  // ANY: no
+
+  return 0;
+}
@@ -0,0 +1,59 @@
+// This file is part of SymCC.
+//
+// SymCC is free software: you can redistribute it and/or modify it under the
+// terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or (at your option) any later
+// version.
+//
+// SymCC is distributed in the hope that it will be useful, but WITHOUT ANY
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+// A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// SymCC. If not, see <https://www.gnu.org/licenses/>.
+
+// RUN: %symcc -O2 %s -o %t
+// RUN: echo -n "12ab" | %t 2>&1 | %filecheck %s
+//
+// Functions with optional symbolic models have to work whether or not the
+// run-time library provides the models, and a model that is defined has to be
+// called instead of the libc function.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+static int strlenModelCalls = 0;
+
+size_t strlen_symbolized(const char *s) {
+  strlenModelCalls++;
+  // Calls from the model itself go to libc.
+  return strlen(s);
+}
+
+int main(int argc, char *argv[]) {
+  char buffer[5];
+
+  if (read(STDIN_FILENO, buffer, sizeof(buffer) - 1) != sizeof(buffer) - 1) {
+    fprintf(stderr, "Failed to read the input\n");
+    return -1;
+  }
+
+  buffer[4] = '\0';
+
+  fprintf(stderr, "%d\n", atoi(buffer));
+  // ANY: 12
+
+  fprintf(stderr, "%s\n", strstr(buffer, "ab") != NULL ? "found" : "nope");
+  // ANY: found
+
+  fprintf(stderr, "%s\n", strcmp(buffer, "12ab") == 0 ? "equal" : "different");
+  // ANY: equal
+
+  size_t length = strlen(buffer);
+  fprintf(stderr, "%zu %d\n", length, strlenModelCalls);
+  // ANY: 4 1
+
+  return 0;
+}
@@ -0,0 +1,50 @@
+// This file is part of SymCC.
+//
+// SymCC is free software: you can redistribute it and/or modify it under the
+// terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or (at your option) any later
+// version.
+//
+// SymCC is distributed in the hope that it will be useful, but WITHOUT ANY
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+// A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// SymCC. If not, see <https://www.gnu.org/licenses/>.
+
+// RUN: env SYMCC_SUMMARIZE_LOOPS=1 %symcc -O2 %s -o %t
+// RUN: echo -ne "ab\x00cdefg" | %t 2>&1 | %filecheck %s
+// RUN: env SYMCC_SUMMARIZE_LOOPS=1 %symcc -O2 -g %s -o %t_debug
+// RUN: echo -ne "ab\x00cdefg" | %t_debug 2>&1 | %filecheck %s
+//
+// Make sure that scanning loops produce a single path constraint per exit when
+// loop summarization is enabled at compile time, also in the presence of debug
+// information.
+#include <stddef.h>
+#include <stdio.h>
+#include <unistd.h>
+
+__attribute__((noinline)) size_t scan(const unsigned char *s, size_t n) {
+  size_t i;
+  for (i = 0; i != n; i++)
+    if (s[i] == 0)
+      break;
+  return i;
+}
+
+int main(int argc, char *argv[]) {
+  unsigned char buf[8];
+  ssize_t n = read(STDIN_FILENO, buf, sizeof(buf));
+  if (n != sizeof(buf)) {
+    fprintf(stderr, "Failed to read the input\n");
+    return -1;
+  }
+
+  fprintf(stderr, "%zu\n", scan(buf, sizeof(buf)));
+  // SIMPLE-COUNT-1: Trying to solve
+  // SIMPLE-NOT: Trying to solve
+  // QSYM-COUNT-1: SMT
+  // QSYM-NOT: SMT
+  // ANY: 2
+  return 0;
+}
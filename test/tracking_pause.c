@@ -0,0 +1,85 @@
+// This file is part of SymCC.
+//
+// SymCC is free software: you can redistribute it and/or modify it under the
+// terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or (at your option) any later
+// version.
+//
+// SymCC is distributed in the hope that it will be useful, but WITHOUT ANY
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+// A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// SymCC. If not, see <https://www.gnu.org/licenses/>.
+
+// RUN: %symcc -O2 %s -o %t
+// RUN: env SYMCC_MEMORY_INPUT=1 %t 2>&1 | %filecheck %s
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <symcc_tracking.h>
+
+void symcc_make_symbolic(const void *start, size_t byte_length);
+
+int main(int argc, char *argv[]) {
+  uint8_t x = 0;
+  uint8_t copy;
+  symcc_make_symbolic(&x, sizeof(x));
+
+  symcc_tracking_pause();
+  fprintf(stderr, "%s\n", (x == 42) ? "yes" : "no");
+  // SIMPLE-NOT: Trying to solve
+  // QSYM-NOT: SMT
+  // ANY: no
+
+  // Values copied while tracking is paused remain concrete.
+  copy = x;
+  symcc_tracking_resume();
+  fprintf(stderr, "%s\n", (copy == 43) ? "yes" : "no");
+  // SIMPLE-NOT: Trying to solve
+  // QSYM-NOT: SMT
+  // ANY: no
+
+  fprintf(stderr, "%s\n", (x == 44) ? "yes" : "no");
+  // SIMPLE: Trying to solve
+  // SIMPLE: Found diverging input
+  // SIMPLE: stdin0 -> #x2c
+  // QSYM: SMT
+  // ANY: no
+
+  // Without any calls between the regions, the optimizer must not merge the
+  // loads on either side of the pause, and values that were symbolic before
+  // the pause must not produce path constraints while tracking is paused.
+  uint8_t before = x;
+  symcc_tracking_pause();
+  if (before == 45)
+    fputs("unexpected\n", stderr);
+  copy = x;
+  symcc_tracking_resume();
+  uint8_t after = x;
+  fprintf(stderr, "%s\n", (copy == 47 || after == 48) ? "yes" : "no");
+  // SIMPLE-NOT: stdin0 -> #x2d
+  // SIMPLE-NOT: stdin0 -> #x2f
+  // SIMPLE: stdin0 -> #x30
+  // QSYM: SMT
+  // ANY: no
+
+  // Pauses nest, so tracking only resumes when the outer pause ends.
+  symcc_tracking_pause();
+  symcc_tracking_pause();
+  symcc_tracking_resume();
+  fprintf(stderr, "%s\n", (x == 49) ? "yes" : "no");
+  // SIMPLE-NOT: Trying to solve
+  // QSYM-NOT: SMT
+  // ANY: no
+
+  symcc_tracking_resume();
+  fprintf(stderr, "%s\n", (x == 50) ? "yes" : "no");
+  // SIMPLE: Trying to solve
+  // SIMPLE: Found diverging input
+  // SIMPLE: stdin0 -> #x32
+  // QSYM: SMT
+  // ANY: no
+
+  return 0;
+}
@@ -0,0 +1,55 @@
+// This file is part of SymCC.
+//
+// SymCC is free software: you can redistribute it and/or modify it under the
+// terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or (at your option) any later
+// version.
+//
+// SymCC is distributed in the hope that it will be useful, but WITHOUT ANY
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+// A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// SymCC. If not, see <https://www.gnu.org/licenses/>.
+
+// RUN: %symcc -O2 -fno-exceptions %s -o %t
+// RUN: env SYMCC_MEMORY_INPUT=1 %t 2>&1 | %filecheck %s
+//
+// The scope guard from symcc_tracking.h pauses symbolic tracking until it goes
+// out of scope, and nested guards don't resume tracking early.
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <symcc_tracking.h>
+
+extern "C" void symcc_make_symbolic(const void *start, size_t byte_length);
+
+int main() {
+  uint8_t x = 0;
+  symcc_make_symbolic(&x, sizeof(x));
+
+  {
+    SymccTrackingPause outer;
+    {
+      SymccTrackingPause inner;
+      fprintf(stderr, "%s\n", (x == 42) ? "yes" : "no");
+      // SIMPLE-NOT: Trying to solve
+      // QSYM-NOT: SMT
+      // ANY: no
+    }
+
+    fprintf(stderr, "%s\n", (x == 43) ? "yes" : "no");
+    // SIMPLE-NOT: Trying to solve
+    // QSYM-NOT: SMT
+    // ANY: no
+  }
+
+  fprintf(stderr, "%s\n", (x == 44) ? "yes" : "no");
+  // SIMPLE: Trying to solve
+  // SIMPLE: Found diverging input
+  // SIMPLE: stdin0 -> #x2c
+  // QSYM: SMT
+  // ANY: no
+
+  return 0;
+}
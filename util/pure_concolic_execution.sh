@@ -3,7 +3,7 @@
 set -u
 
 function usage() {
-    echo "Usage: $0 -i INPUT_DIR [-o OUTPUT_DIR] [-f FAILED_DIR] TARGET..."
+    echo "Usage: $0 -i INPUT_DIR [-o OUTPUT_DIR] [-f FAILED_DIR] [-s STRATEGY] TARGET..."
     echo
     echo "Run SymCC-instrumented TARGET in a loop, feeding newly generated inputs back "
     echo "into it. Initial inputs are expected in INPUT_DIR, and new inputs are "
@@ -12,11 +12,17 @@ function usage() {
     echo "string \"@@\", which is replaced with the name of the current input file."
     echo "If FAILED_DIR is specified, a copy of the failing test cases is preserved there."
     echo
+    echo "STRATEGY selects the order in which pending inputs are run: \"bfs\" (the "
+    echo "default) runs the oldest input first, exploring generation by generation; "
+    echo "\"dfs\" runs the newest input first, following one chain of derived inputs "
+    echo "as deep as it goes; \"random\" picks any pending input at random."
+    echo
     echo "Note that SymCC never changes the length of the input, so be sure that the "
     echo "initial inputs cover all required input lengths."
 }
 
-while getopts "i:o:f:" opt; do
+strategy=bfs
+while getopts "i:o:f:s:" opt; do
     case "$opt" in
         i)
             in=$OPTARG
@@ -27,6 +33,9 @@ while getopts "i:o:f:" opt; do
         f)
             failed_dir=$OPTARG
             ;;
+        s)
+            strategy=$OPTARG
+            ;;
         *)
             usage
             exit 1
@@ -45,9 +54,15 @@ if [[ ! -v in ]]; then
     exit 1
 fi
 
+if [[ ! "$strategy" =~ ^(bfs|dfs|random)$ ]]; then
+    echo "Unknown scheduling strategy \"$strategy\"!"
+    usage
+    exit 1
+fi
+
 # Create the work environment
 work_dir=$(mktemp -d)
-mkdir $work_dir/{next,symcc_out}
+mkdir $work_dir/{next,cur,symcc_out}
 touch $work_dir/analyzed_inputs
 if [[ -v out ]]; then
     mkdir -p $out
@@ -86,10 +101,39 @@ function copy_with_unique_name() {
     fi
 }
 
-# Copy files from the source directory into the next generation.
-function add_to_next_generation() {
+# Copy files from the source directory into the pool of pending inputs,
+# renaming them according to their hash. Inputs that are already pending keep
+# their place: copying them again would refresh their modification time, which
+# determines the scheduling order.
+function add_to_pending_inputs() {
     local source_dir="$1"
-    copy_with_unique_name "$source_dir" "$work_dir/next"
+
+    if [ -n "$(ls -A $source_dir)" ]; then
+        local f
+        for f in $source_dir/*; do
+            local dest="$work_dir/next/$(sha256sum "$f" | cut -d' ' -f1)"
+            if [ ! -e "$dest" ]; then
+                cp "$f" "$dest"
+            fi
+        done
+    fi
+}
+
+# Print the name of the pending input to run next according to the scheduling
+# strategy (or nothing if there is no pending input). Inputs enter the pool as
+# fresh copies, so their modification time tells us when they were added.
+function pick_next_input() {
+    case "$strategy" in
+        bfs)
+            ls -1tr "$work_dir/next" | head -n 1
+            ;;
+        dfs)
+            ls -1t "$work_dir/next" | head -n 1
+            ;;
+        random)
+            ls -1 "$work_dir/next" | shuf -n 1
+            ;;
+    esac
 }
 
 # If an output directory is set, copy the files in the source directory there.
@@ -111,8 +155,8 @@ function remove_analysed() {
     done
 }
 
-# Copy those files from the input directory to the next generation that haven't
-# been analyzed yet.
+# Copy those files from the input directory to the pool of pending inputs that
+# haven't been analyzed yet.
 function maybe_import() {
     if [ -n "$(ls -A $in)" ]; then
         local f
@@ -145,42 +189,38 @@ export SYMCC_OUTPUT_DIR=$work_dir/symcc_out
 export SYMCC_ENABLE_LINEARIZATION=1
 # export SYMCC_AFL_COVERAGE_MAP=$work_dir/map
 
-# Run generation after generation until we don't generate new inputs anymore
-gen_count=0
+# Run one pending input after the other until we don't generate new inputs
+# anymore
 while true; do
-    # Initialize the generation
     maybe_import
-    mv $work_dir/{next,cur}
-    mkdir $work_dir/next
 
     # Run it (or wait if there's nothing to run on)
-    if [ -n "$(ls -A $work_dir/cur)" ]; then
-        echo "Generation $gen_count..."
-
-        for f in $work_dir/cur/*; do
-            echo "Running on $f"
-            if [[ "$target " =~ " @@ " ]]; then
-                env SYMCC_INPUT_FILE=$f $timeout ${target[@]/@@/$f} >/dev/null 2>&1
-                ret_code=$?
-            else
-                $timeout $target <$f >/dev/null 2>&1
-                ret_code=$?
-            fi
-
-            # Make the new test cases part of the next generation
-            add_to_next_generation $work_dir/symcc_out
-            maybe_export $work_dir/symcc_out
-            remove_analysed $work_dir/next
-            save_failed $ret_code "$f"
-            echo $(basename $f) >> $work_dir/analyzed_inputs
-            rm -f $f
-        done
+    next_input=$(pick_next_input)
+    if [ -n "$next_input" ]; then
+        f=$work_dir/cur/$next_input
+        mv "$work_dir/next/$next_input" "$f"
+
+        echo "Running on $f"
+        if [[ "$target " =~ " @@ " ]]; then
+            env SYMCC_INPUT_FILE=$f $timeout ${target[@]/@@/$f} >/dev/null 2>&1
+            ret_code=$?
+        else
+            $timeout $target <$f >/dev/null 2>&1
+            ret_code=$?
+        fi
 
-        rm -rf $work_dir/cur
-        gen_count=$((gen_count+1))
+        # Make the new test cases pending inputs; clear the output directory so
+        # that later runs don't add them again (which would make them look new
+        # to the scheduler).
+        add_to_pending_inputs $work_dir/symcc_out
+        maybe_export $work_dir/symcc_out
+        rm -f $work_dir/symcc_out/*
+        remove_analysed $work_dir/next
+        save_failed $ret_code "$f"
+        echo $(basename $f) >> $work_dir/analyzed_inputs
+        rm -f $f
     else
         echo "Waiting for more input..."
-        rmdir $work_dir/cur
         sleep 5
     fi
 done
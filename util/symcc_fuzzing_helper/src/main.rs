@@ -12,11 +12,12 @@
 // You should have received a copy of the GNU General Public License along with
 // SymCC. If not, see <https://www.gnu.org/licenses/>.
 
+mod ring;
 mod symcc;
 
 use anyhow::{Context, Result};
 use clap::{self, StructOpt};
-use std::collections::HashSet;
+use std::collections::{BTreeMap, HashSet};
 use std::fs;
 use std::fs::File;
 use std::io::Write;
@@ -71,6 +72,9 @@ struct Stats {
 
     /// Time spent in failed SymCC executions.
     failed_time: Duration,
+
+    /// Cumulative counters reported by the backend (maximum for peak values).
+    runtime_counters: BTreeMap<String, u64>,
 }
 
 impl Stats {
@@ -88,6 +92,18 @@ impl Stats {
                 (Some(a), Some(b)) => Some(a + b),
             };
         }
+
+        if let Some(runtime_stats) = &result.runtime_stats {
+            for (name, value) in runtime_stats.counters.iter() {
+                let total = self.runtime_counters.entry(name.clone()).or_insert(0);
+                // Peak values don't add up across executions.
+                if name.starts_with("peak_") {
+                    *total = (*total).max(*value);
+                } else {
+                    *total += value;
+                }
+            }
+        }
     }
 
     fn log(&self, out: &mut impl Write) -> Result<()> {
@@ -145,6 +161,10 @@ impl Stats {
             )?;
         }
 
+        for (name, value) in self.runtime_counters.iter() {
+            writeln!(out, "Backend counter {}: {}", name, value)?;
+        }
+
         writeln!(
             out,
             "--------------------------------------------------------------------------------"
@@ -229,17 +249,17 @@ impl State {
         let mut num_total = 0u64;
 
         let symcc_result = symcc
-            .run(&input, tmp_dir.path().join("output"))
+            .run(&input, tmp_dir.path().join("output"), |new_test| {
+                let res = process_new_testcase(&new_test, &input, &tmp_dir, &afl_config, self)?;
+
+                num_total += 1;
+                if res == TestcaseResult::New {
+                    log::debug!("Test case is interesting");
+                    num_interesting += 1;
+                }
+                Ok(())
+            })
             .context("Failed to run SymCC")?;
-        for new_test in symcc_result.test_cases.iter() {
-            let res = process_new_testcase(&new_test, &input, &tmp_dir, &afl_config, self)?;
-
-            num_total += 1;
-            if res == TestcaseResult::New {
-                log::debug!("Test case is interesting");
-                num_interesting += 1;
-            }
-        }
 
         log::info!(
             "Generated {} test cases ({} new)",
@@ -0,0 +1,274 @@
+// This file is part of SymCC.
+//
+// SymCC is free software: you can redistribute it and/or modify it under the
+// terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or (at your option) any later
+// version.
+//
+// SymCC is distributed in the hope that it will be useful, but WITHOUT ANY
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+// A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// SymCC. If not, see <https://www.gnu.org/licenses/>.
+
+use anyhow::{ensure, Context, Result};
+use std::cmp;
+use std::os::unix::fs::FileExt;
+use std::path::Path;
+use tempfile::NamedTempFile;
+
+/// The marker at the start of a ring buffer.
+const RING_MAGIC: &[u8] = b"SYMRING1";
+
+/// The location of the data area's size in the header.
+const CAPACITY_OFFSET: u64 = 8;
+
+/// The location of the producer's position in the header.
+const HEAD_OFFSET: u64 = 16;
+
+/// The location of the consumer's position in the header.
+const TAIL_OFFSET: u64 = 24;
+
+/// The size of the header; the data area starts right after it.
+const HEADER_SIZE: u64 = 64;
+
+/// The bit in a record's length field that marks the data as a patch.
+const PATCH_FLAG: u32 = 1 << 31;
+
+/// A test case from the ring buffer.
+#[derive(Debug, PartialEq, Eq)]
+pub struct StreamedTestcase {
+    /// The data of the test case, or a patch against the input of the current
+    /// execution.
+    pub data: Vec<u8>,
+
+    /// Is the data a patch (see `SYMCC_OUTPUT_PATCHES`)?
+    pub is_patch: bool,
+}
+
+/// A ring buffer in shared memory that the backend streams test cases into.
+///
+/// The backend maps the file named in `SYMCC_TESTCASE_RING` and appends each
+/// new test case as soon as it is solved, so that we can evaluate it while the
+/// target is still running. The file starts with a header, consisting of the
+/// magic bytes "SYMRING1" followed by three 64-bit little-endian integers: the
+/// size of the data area, the total number of bytes that the producer has
+/// written (the head), and the total number of bytes that the consumer has
+/// read (the tail). Each test case is a record made up of its 32-bit
+/// little-endian length and the data; records wrap around at the end of the
+/// data area. The most significant bit of the length marks data that is a
+/// patch rather than a full test case. The producer updates the head only
+/// after writing a complete record, and it has to publish the new head with
+/// release ordering: we read the record as soon as we see the head, so the
+/// data must be visible by then. If a test case doesn't fit into the free
+/// space, the backend writes it to the output directory as usual. If we find
+/// the buffer in an inconsistent state, we stop reading from it.
+pub struct TestcaseRing {
+    /// The file backing the ring buffer.
+    file: NamedTempFile,
+
+    /// The size of the data area.
+    capacity: u64,
+
+    /// The total number of bytes that we have consumed.
+    tail: u64,
+}
+
+impl TestcaseRing {
+    /// Create an empty ring buffer with the given capacity.
+    ///
+    /// We put the file in /dev/shm if possible, so that its contents never hit
+    /// the disk.
+    pub fn new(capacity: u64) -> Result<Self> {
+        let shm = Path::new("/dev/shm");
+        let file = if shm.is_dir() {
+            NamedTempFile::new_in(shm)
+        } else {
+            NamedTempFile::new()
+        }
+        .context("Failed to create the ring buffer for test cases")?;
+
+        let mut header = RING_MAGIC.to_vec();
+        header.extend_from_slice(&capacity.to_le_bytes());
+        file.as_file()
+            .set_len(HEADER_SIZE + capacity)
+            .and_then(|_| file.as_file().write_all_at(&header, 0))
+            .with_context(|| {
+                format!(
+                    "Failed to initialize the ring buffer at {}",
+                    file.path().display()
+                )
+            })?;
+
+        Ok(TestcaseRing {
+            file,
+            capacity,
+            tail: 0,
+        })
+    }
+
+    /// The location of the file backing the ring buffer.
+    pub fn path(&self) -> &Path {
+        self.file.path()
+    }
+
+    fn read_header_field(&self, offset: u64) -> Result<u64> {
+        let mut bytes = [0u8; 8];
+        self.file
+            .as_file()
+            .read_exact_at(&mut bytes, offset)
+            .context("Failed to read the header of the ring buffer")?;
+        Ok(u64::from_le_bytes(bytes))
+    }
+
+    /// Fill the buffer with data starting at the given position, wrapping
+    /// around at the end of the data area.
+    fn read_data(&self, position: u64, buf: &mut [u8]) -> Result<()> {
+        let start = position % self.capacity;
+        let first_part = cmp::min(buf.len() as u64, self.capacity - start) as usize;
+        let (first, second) = buf.split_at_mut(first_part);
+        self.file
+            .as_file()
+            .read_exact_at(first, HEADER_SIZE + start)
+            .and_then(|_| self.file.as_file().read_exact_at(second, HEADER_SIZE))
+            .context("Failed to read from the ring buffer")
+    }
+
+    /// Remove all complete test cases from the ring buffer and return them.
+    pub fn drain(&mut self) -> Result<Vec<StreamedTestcase>> {
+        let head = self.read_header_field(HEAD_OFFSET)?;
+        ensure!(
+            head >= self.tail && head - self.tail <= self.capacity,
+            "The ring buffer is corrupt (head {}, tail {})",
+            head,
+            self.tail
+        );
+
+        let mut testcases = Vec::new();
+        while self.tail < head {
+            let mut length = [0u8; 4];
+            ensure!(
+                head - self.tail >= 4,
+                "Incomplete record in the ring buffer"
+            );
+            self.read_data(self.tail, &mut length)?;
+            let length = u32::from_le_bytes(length);
+            let is_patch = length & PATCH_FLAG != 0;
+            let length = u64::from(length & !PATCH_FLAG);
+            ensure!(
+                head - self.tail - 4 >= length,
+                "Incomplete record in the ring buffer"
+            );
+
+            let mut data = vec![0u8; length as usize];
+            self.read_data(self.tail + 4, &mut data)?;
+            self.tail += 4 + length;
+            testcases.push(StreamedTestcase { data, is_patch });
+        }
+
+        // Tell the producer that the space is available again.
+        self.file
+            .as_file()
+            .write_all_at(&self.tail.to_le_bytes(), TAIL_OFFSET)
+            .context("Failed to update the ring buffer")?;
+
+        Ok(testcases)
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use std::fs::OpenOptions;
+
+    /// Append a test case like the backend would; return false if it doesn't
+    /// fit.
+    fn produce_record(path: &Path, testcase: &[u8], is_patch: bool) -> bool {
+        let file = OpenOptions::new()
+            .read(true)
+            .write(true)
+            .open(path)
+            .unwrap();
+        let field = |offset| {
+            let mut bytes = [0u8; 8];
+            file.read_exact_at(&mut bytes, offset).unwrap();
+            u64::from_le_bytes(bytes)
+        };
+        let (capacity, head, tail) = (
+            field(CAPACITY_OFFSET),
+            field(HEAD_OFFSET),
+            field(TAIL_OFFSET),
+        );
+
+        let length = testcase.len() as u32 | if is_patch { PATCH_FLAG } else { 0 };
+        let mut record = length.to_le_bytes().to_vec();
+        record.extend_from_slice(testcase);
+        if capacity - (head - tail) < record.len() as u64 {
+            return false;
+        }
+
+        for (i, byte) in record.iter().enumerate() {
+            let position = (head + i as u64) % capacity;
+            file.write_all_at(&[*byte], HEADER_SIZE + position).unwrap();
+        }
+        file.write_all_at(&(head + record.len() as u64).to_le_bytes(), HEAD_OFFSET)
+            .unwrap();
+        true
+    }
+
+    fn produce(path: &Path, testcase: &[u8]) -> bool {
+        produce_record(path, testcase, false)
+    }
+
+    /// Drain the ring buffer, expecting only full test cases.
+    fn drain_full(ring: &mut TestcaseRing) -> Vec<Vec<u8>> {
+        ring.drain()
+            .unwrap()
+            .into_iter()
+            .map(|testcase| {
+                assert!(!testcase.is_patch);
+                testcase.data
+            })
+            .collect()
+    }
+
+    #[test]
+    fn test_ring_streaming() {
+        let mut ring = TestcaseRing::new(16).unwrap();
+        assert!(ring.drain().unwrap().is_empty());
+
+        assert!(produce(ring.path(), b"abc"));
+        assert!(produce(ring.path(), b""));
+        assert_eq!(drain_full(&mut ring), vec![b"abc".to_vec(), vec![]]);
+
+        // The next records wrap around the end of the data area.
+        assert!(produce(ring.path(), b"defgh"));
+        assert!(produce(ring.path(), b"ij"));
+        assert!(!produce(ring.path(), b"klm"));
+        assert_eq!(
+            drain_full(&mut ring),
+            vec![b"defgh".to_vec(), b"ij".to_vec()]
+        );
+
+        assert!(produce(ring.path(), b"klmnopqrstuv"));
+        assert_eq!(drain_full(&mut ring), vec![b"klmnopqrstuv".to_vec()]);
+
+        // Patches are marked in the length field, not in the data.
+        assert!(produce_record(ring.path(), b"full", false));
+        assert!(produce_record(ring.path(), b"xy", true));
+        assert_eq!(
+            ring.drain().unwrap(),
+            vec![
+                StreamedTestcase {
+                    data: b"full".to_vec(),
+                    is_patch: false
+                },
+                StreamedTestcase {
+                    data: b"xy".to_vec(),
+                    is_patch: true
+                }
+            ]
+        );
+    }
+}
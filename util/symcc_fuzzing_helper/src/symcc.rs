@@ -12,10 +12,11 @@
 // You should have received a copy of the GNU General Public License along with
 // SymCC. If not, see <https://www.gnu.org/licenses/>.
 
+use crate::ring::TestcaseRing;
 use anyhow::{bail, ensure, Context, Result};
 use regex::Regex;
 use std::cmp;
-use std::collections::HashSet;
+use std::collections::{BTreeMap, HashSet};
 use std::ffi::{OsStr, OsString};
 use std::fs::{self, File};
 use std::io::{self, Read};
@@ -23,10 +24,21 @@ use std::os::unix::process::ExitStatusExt;
 use std::path::{Path, PathBuf};
 use std::process::{Command, Stdio};
 use std::str;
+use std::sync::mpsc::{self, RecvTimeoutError};
+use std::thread;
 use std::time::{Duration, Instant};
 
 const TIMEOUT: u32 = 90;
 
+/// The size of the ring buffer for streaming test cases.
+///
+/// The backing file is sparse, so memory is only used as the buffer fills up.
+const RING_CAPACITY: u64 = 64 << 20;
+
+/// How often to check the ring buffer for new test cases while the target is
+/// running.
+const RING_POLL_INTERVAL: Duration = Duration::from_millis(100);
+
 /// Replace the first '@@' in the given command line with the input file.
 fn insert_input_file<S: AsRef<OsStr>, P: AsRef<Path>>(
     command: &[S],
@@ -226,6 +238,142 @@ pub fn copy_testcase(
     Ok(())
 }
 
+/// The origin of a test case according to its name in an AFL queue.
+#[derive(Debug, PartialEq, Eq)]
+enum TestcaseOrigin<'a> {
+    /// The test case was derived from the one with the given ID in the same
+    /// queue.
+    Local(&'a str),
+
+    /// The test case was imported from the queue of another fuzzer, where it
+    /// has the given ID.
+    Synced { fuzzer: &'a str, id: &'a str },
+}
+
+/// Extract the ID from the name of a test case in an AFL queue.
+fn testcase_id(name: &str) -> Option<&str> {
+    name.split(',').next()?.strip_prefix("id:")
+}
+
+/// Determine where a test case comes from, based on the "src" and "sync"
+/// fields in its name.
+///
+/// Test cases without a source (e.g., the initial seeds) have no origin. If
+/// AFL spliced two test cases, we consider the first one to be the parent.
+fn testcase_origin(name: &str) -> Option<TestcaseOrigin<'_>> {
+    let mut fuzzer = None;
+    let mut source = None;
+    for field in name.split(',') {
+        if let Some(value) = field.strip_prefix("sync:") {
+            fuzzer = Some(value);
+        } else if let Some(value) = field.strip_prefix("src:") {
+            source = value.split('+').next();
+        }
+    }
+
+    let id = source.filter(|id| !id.is_empty())?;
+    Some(match fuzzer {
+        Some(fuzzer) => TestcaseOrigin::Synced { fuzzer, id },
+        None => TestcaseOrigin::Local(id),
+    })
+}
+
+/// The file-name extension of test cases that are stored as patches.
+const PATCH_EXTENSION: &str = "patch";
+
+/// The largest test case that we reconstruct from a patch.
+///
+/// AFL doesn't handle inputs of more than 1 MB anyway; the limit just keeps a
+/// corrupt length field from making us allocate huge amounts of memory.
+const MAX_PATCHED_TESTCASE_SIZE: u64 = 64 << 20;
+
+/// Read a little-endian integer of N bytes from the start of the buffer and
+/// advance it.
+fn take_le<const N: usize>(data: &mut &[u8]) -> Result<u64> {
+    ensure!(data.len() >= N, "The patch is truncated");
+    let (bytes, rest) = data.split_at(N);
+    *data = rest;
+    Ok(bytes
+        .iter()
+        .rev()
+        .fold(0u64, |value, byte| (value << 8) | u64::from(*byte)))
+}
+
+/// Reconstruct a test case from its patch against the parent input.
+///
+/// Test cases for large inputs typically differ from the input in just a few
+/// bytes, so the backend may store them as patches instead of full copies
+/// (see `SYMCC_OUTPUT_PATCHES`). A patch consists of the length of the test
+/// case and a sequence of records, each made up of an offset, a length, and
+/// the bytes to write at that offset (offsets and test-case length are 64-bit,
+/// record lengths 32-bit, all in little endian). The parent is truncated or
+/// padded with zeros to the test-case length before the records are applied.
+/// Patches are marked outside the data, so that any full test case is valid;
+/// see docs/Configuration.txt for a description of the interface.
+fn apply_patch(patch: &[u8], parent: &[u8]) -> Result<Vec<u8>> {
+    let mut data = patch;
+    let length = take_le::<8>(&mut data)?;
+    ensure!(
+        length <= MAX_PATCHED_TESTCASE_SIZE,
+        "The patched test case would be too large ({} bytes)",
+        length
+    );
+    let length = length as usize;
+    let mut testcase = parent.to_vec();
+    testcase.resize(length, 0);
+
+    while !data.is_empty() {
+        let offset = take_le::<8>(&mut data)? as usize;
+        let record_length = take_le::<4>(&mut data)? as usize;
+        ensure!(data.len() >= record_length, "The patch is truncated");
+        ensure!(
+            offset
+                .checked_add(record_length)
+                .map_or(false, |end| end <= length),
+            "The patch writes beyond the end of the test case"
+        );
+
+        let (bytes, rest) = data.split_at(record_length);
+        testcase[offset..offset + record_length].copy_from_slice(bytes);
+        data = rest;
+    }
+
+    Ok(testcase)
+}
+
+/// Replace a test case that is stored as a patch (i.e., in a file with the
+/// extension ".patch") with the full data, and return the location of the full
+/// test case.
+///
+/// Return None if the patch can't be applied (e.g., because the target was
+/// killed while writing it); such test cases should be ignored.
+fn materialize_testcase(testcase: &Path, parent: &[u8]) -> Result<Option<PathBuf>> {
+    if testcase.extension() != Some(OsStr::new(PATCH_EXTENSION)) {
+        return Ok(Some(testcase.to_path_buf()));
+    }
+
+    let patch = fs::read(testcase)
+        .with_context(|| format!("Failed to read the test case {}", testcase.display()))?;
+    fs::remove_file(testcase)
+        .with_context(|| format!("Failed to remove the patch {}", testcase.display()))?;
+    match apply_patch(&patch, parent) {
+        Ok(full) => {
+            let path = testcase.with_extension("");
+            fs::write(&path, full)
+                .with_context(|| format!("Failed to write the test case {}", path.display()))?;
+            Ok(Some(path))
+        }
+        Err(e) => {
+            log::warn!(
+                "Ignoring test case {} with an invalid patch: {}",
+                testcase.display(),
+                e
+            );
+            Ok(None)
+        }
+    }
+}
+
 /// Information on the run-time environment.
 ///
 /// This should not change during execution.
@@ -394,6 +542,51 @@ impl AflConfig {
     }
 }
 
+/// Statistics that the backend reports on an execution.
+///
+/// We pass a file name in `SYMCC_STATS_FILE`, and a backend that supports it
+/// writes a single flat JSON object to that file when the target terminates,
+/// mapping the names of counters to non-negative integers. The counters that
+/// we know about are the solver time in microseconds ("solver_time_us"), the
+/// number of queries and their outcomes ("queries", "queries_sat",
+/// "queries_unsat", "queries_timeout"), the number of generated test cases
+/// ("test_cases"), the number of allocated expressions and their peak memory
+/// use ("expressions", "peak_expression_bytes"), the number of shadow pages
+/// ("shadow_pages"), and the number of calls to each expression builder (e.g.,
+/// "build_add" for `_sym_build_add`). Any other integer counters are kept as
+/// well.
+#[derive(Debug, Default, PartialEq, Eq)]
+pub struct RuntimeStats {
+    /// The values of all counters, by name.
+    pub counters: BTreeMap<String, u64>,
+}
+
+impl RuntimeStats {
+    /// Parse the statistics written by the backend.
+    ///
+    /// Return None if the data doesn't contain any counters.
+    fn parse(data: &str) -> Option<Self> {
+        let re = Regex::new(r#""([^"\\]+)"\s*:\s*(\d+)"#).unwrap();
+        let counters: BTreeMap<_, _> = re
+            .captures_iter(data)
+            .filter_map(|c| Some((c[1].to_string(), c[2].parse().ok()?)))
+            .collect();
+
+        if counters.is_empty() {
+            None
+        } else {
+            Some(RuntimeStats { counters })
+        }
+    }
+
+    /// The time that the backend spent in the solver.
+    pub fn solver_time(&self) -> Option<Duration> {
+        self.counters
+            .get("solver_time_us")
+            .map(|t| Duration::from_micros(*t))
+    }
+}
+
 /// The run-time configuration of SymCC.
 #[derive(Debug)]
 pub struct SymCC {
@@ -406,20 +599,33 @@ pub struct SymCC {
     /// The place to store the current input.
     input_file: PathBuf,
 
+    /// The place for the backend's statistics on the current execution.
+    stats_file: PathBuf,
+
+    /// Our name in the AFL output directory.
+    name: OsString,
+
+    /// Our queue of test cases.
+    queue: PathBuf,
+
+    /// The directory for the records of the branches that the backend tried
+    /// to negate, one file per AFL test case.
+    branch_records: PathBuf,
+
     /// The command to run.
     command: Vec<OsString>,
 }
 
 /// The result of executing SymCC.
 pub struct SymCCResult {
-    /// The generated test cases.
-    pub test_cases: Vec<PathBuf>,
     /// Whether the process was killed (e.g., out of memory, timeout).
     pub killed: bool,
     /// The total time taken by the execution.
     pub time: Duration,
     /// The time spent in the solver (Qsym backend only).
     pub solver_time: Option<Duration>,
+    /// The statistics reported by the backend, if it supports them.
+    pub runtime_stats: Option<RuntimeStats>,
 }
 
 impl SymCC {
@@ -432,11 +638,18 @@ impl SymCC {
             bitmap: output_dir.join("bitmap"),
             command: insert_input_file(command, &input_file),
             input_file,
+            stats_file: output_dir.join(".cur_stats"),
+            name: output_dir.file_name().unwrap_or_default().to_owned(),
+            queue: output_dir.join("queue"),
+            branch_records: output_dir.join("branches"),
         }
     }
 
     /// Try to extract the solver time from the logs produced by the Qsym
     /// backend.
+    ///
+    /// This is only a fallback for backends that don't write statistics to
+    /// `SYMCC_STATS_FILE`.
     fn parse_solver_time(output: Vec<u8>) -> Option<Duration> {
         let re = Regex::new(r#""solving_time": (\d+)"#).unwrap();
         output
@@ -456,17 +669,103 @@ impl SymCC {
             .next()
     }
 
+    /// Find the record of the branches that the backend tried to negate when
+    /// it executed the parent of the given AFL test case, if any.
+    ///
+    /// If the test case was imported from our own queue, its parent is the
+    /// AFL test case that we derived it from (see `copy_testcase`).
+    fn parent_branch_record(&self, name: &str) -> Option<PathBuf> {
+        let parent_id = match testcase_origin(name)? {
+            TestcaseOrigin::Local(id) => id.to_string(),
+            TestcaseOrigin::Synced { fuzzer, id } if OsStr::new(fuzzer) == self.name => {
+                let prefix = format!("id:{},", id);
+                let our_name = fs::read_dir(&self.queue)
+                    .ok()?
+                    .filter_map(|entry| entry.ok())
+                    .map(|entry| entry.file_name().to_string_lossy().into_owned())
+                    .find(|our_name| our_name.starts_with(&prefix))?;
+                match testcase_origin(&our_name)? {
+                    TestcaseOrigin::Local(id) => id.to_string(),
+                    TestcaseOrigin::Synced { .. } => return None,
+                }
+            }
+            TestcaseOrigin::Synced { .. } => return None,
+        };
+
+        let record = self.branch_records.join(parent_id);
+        if record.is_file() {
+            Some(record)
+        } else {
+            None
+        }
+    }
+
+    /// Write the test cases from the ring buffer to the output directory and
+    /// pass them to the handler.
+    ///
+    /// If the ring buffer turns out to be corrupt, we log the problem and stop
+    /// reading from it for the rest of the execution; once the ring buffer is
+    /// full, the backend writes new test cases to the output directory again.
+    fn stream_testcases(
+        ring: &mut Option<TestcaseRing>,
+        parent: &[u8],
+        output_dir: &Path,
+        streamed: &mut HashSet<PathBuf>,
+        handle_testcase: &mut impl FnMut(&Path) -> Result<()>,
+    ) -> Result<()> {
+        let testcases = match ring.as_mut().map(TestcaseRing::drain) {
+            None => return Ok(()),
+            Some(Ok(testcases)) => testcases,
+            Some(Err(e)) => {
+                log::warn!("Ignoring the ring buffer for this execution: {}", e);
+                *ring = None;
+                return Ok(());
+            }
+        };
+
+        for testcase in testcases {
+            let data = if testcase.is_patch {
+                match apply_patch(&testcase.data, parent) {
+                    Ok(full) => full,
+                    Err(e) => {
+                        log::warn!("Ignoring an invalid patch in the ring buffer: {}", e);
+                        continue;
+                    }
+                }
+            } else {
+                testcase.data
+            };
+            let path = output_dir.join(format!("streamed-{:06}", streamed.len()));
+            fs::write(&path, data)
+                .with_context(|| format!("Failed to write the test case {}", path.display()))?;
+            handle_testcase(&path)?;
+            streamed.insert(path);
+        }
+
+        Ok(())
+    }
+
     /// Run SymCC on the given input, writing results to the provided temporary
-    /// directory.
+    /// directory, and pass each generated test case to the handler.
     ///
-    /// If SymCC is run with the Qsym backend, this function attempts to
-    /// determine the time spent in the SMT solver and report it as part of the
-    /// result. However, the mechanism that the backend uses to report solver
-    /// time is somewhat brittle.
+    /// Test cases that the backend streams through the ring buffer are handled
+    /// while the target is still running; the others are collected from the
+    /// output directory after the target terminates.
+    ///
+    /// For test cases from the AFL queue, we set `SYMCC_BRANCH_RECORD` to a
+    /// file in the directory of branch records that is named after the test
+    /// case's ID, and `SYMCC_PARENT_BRANCH_RECORD` to the record of the test
+    /// case's parent if that file exists.
+    ///
+    /// The result contains the statistics that the backend reports, if any.
+    /// Otherwise, if SymCC is run with the Qsym backend, this function attempts
+    /// to determine the time spent in the SMT solver from its logs; however,
+    /// that mechanism is somewhat brittle.
     pub fn run(
         &self,
         input: impl AsRef<Path>,
         output_dir: impl AsRef<Path>,
+        mut handle_testcase: impl FnMut(&Path) -> Result<()>,
     ) -> Result<SymCCResult> {
         fs::copy(&input, &self.input_file).with_context(|| {
             format!(
@@ -475,6 +774,12 @@ impl SymCC {
                 self.input_file.display()
             )
         })?;
+        let parent = fs::read(&self.input_file).with_context(|| {
+            format!(
+                "Failed to read the test input at {}",
+                self.input_file.display()
+            )
+        })?;
 
         fs::create_dir(&output_dir).with_context(|| {
             format!(
@@ -483,6 +788,29 @@ impl SymCC {
             )
         })?;
 
+        // Make sure that we don't pick up statistics from an earlier execution.
+        if let Err(e) = fs::remove_file(&self.stats_file) {
+            ensure!(
+                e.kind() == io::ErrorKind::NotFound,
+                "Failed to remove the old statistics at {}: {}",
+                self.stats_file.display(),
+                e
+            );
+        }
+
+        fs::create_dir_all(&self.branch_records).with_context(|| {
+            format!(
+                "Failed to create the directory {} for branch records",
+                self.branch_records.display()
+            )
+        })?;
+        let input_name = input
+            .as_ref()
+            .file_name()
+            .unwrap_or_default()
+            .to_string_lossy();
+
+        let ring = TestcaseRing::new(RING_CAPACITY)?;
         let mut analysis_command = Command::new("timeout");
         analysis_command
             .args(&["-k", "5", &TIMEOUT.to_string()])
@@ -490,9 +818,19 @@ impl SymCC {
             .env("SYMCC_ENABLE_LINEARIZATION", "1")
             .env("SYMCC_AFL_COVERAGE_MAP", &self.bitmap)
             .env("SYMCC_OUTPUT_DIR", output_dir.as_ref())
+            .env("SYMCC_OUTPUT_PATCHES", "1")
+            .env("SYMCC_TESTCASE_RING", ring.path())
+            .env("SYMCC_STATS_FILE", &self.stats_file)
             .stdout(Stdio::null())
             .stderr(Stdio::piped()); // capture SMT logs
 
+        if let Some(id) = testcase_id(&input_name) {
+            analysis_command.env("SYMCC_BRANCH_RECORD", self.branch_records.join(id));
+        }
+        if let Some(record) = self.parent_branch_record(&input_name) {
+            analysis_command.env("SYMCC_PARENT_BRANCH_RECORD", record);
+        }
+
         if self.use_standard_input {
             analysis_command.stdin(Stdio::piped());
         } else {
@@ -506,12 +844,7 @@ impl SymCC {
 
         if self.use_standard_input {
             io::copy(
-                &mut File::open(&self.input_file).with_context(|| {
-                    format!(
-                        "Failed to read the test input at {}",
-                        self.input_file.display()
-                    )
-                })?,
+                &mut parent.as_slice(),
                 child
                     .stdin
                     .as_mut()
@@ -520,17 +853,72 @@ impl SymCC {
             .context("Failed to pipe the test input to SymCC")?;
         }
 
-        let result = child
-            .wait_with_output()
-            .context("Failed to wait for SymCC")?;
-        let total_time = start.elapsed();
-        let killed = match result.status.code() {
+        // Close standard input so that the target sees the end of the data.
+        drop(child.stdin.take());
+
+        // Collect the logs in the background while we process test cases.
+        let mut stderr = child
+            .stderr
+            .take()
+            .expect("Failed to capture the child's standard error");
+        // The log ends when the target terminates, so the reader also tells us
+        // when to stop polling the ring buffer.
+        let (exit_sender, exit_receiver) = mpsc::channel();
+        let log_reader = thread::spawn(move || {
+            let mut log = Vec::new();
+            let result = stderr.read_to_end(&mut log).map(|_| log);
+            let _ = exit_sender.send(Instant::now());
+            result
+        });
+
+        let mut ring = Some(ring);
+        let mut streamed = HashSet::new();
+        let mut end = None;
+        let status = loop {
+            let poll = SymCC::stream_testcases(
+                &mut ring,
+                &parent,
+                output_dir.as_ref(),
+                &mut streamed,
+                &mut handle_testcase,
+            )
+            .and_then(|_| match exit_receiver.recv_timeout(RING_POLL_INTERVAL) {
+                Ok(time) => {
+                    end = Some(time);
+                    child.wait().map(Some).context("Failed to wait for SymCC")
+                }
+                Err(RecvTimeoutError::Disconnected) => {
+                    child.wait().map(Some).context("Failed to wait for SymCC")
+                }
+                // Either the target is still running, or something else holds
+                // on to its standard error.
+                Err(RecvTimeoutError::Timeout) => {
+                    child.try_wait().context("Failed to wait for SymCC")
+                }
+            });
+
+            match poll {
+                Ok(Some(status)) => break status,
+                Ok(None) => {}
+                Err(e) => {
+                    // Don't leave the target running.
+                    let _ = child.kill();
+                    let _ = child.wait();
+                    return Err(e);
+                }
+            }
+        };
+
+        // Processing test cases takes time, so we don't count it as execution
+        // time of the target.
+        let total_time = end.unwrap_or_else(Instant::now).duration_since(start);
+        let killed = match status.code() {
             Some(code) => {
                 log::debug!("SymCC returned code {}", code);
                 (code == 124) || (code == -9) // as per the man-page of timeout
             }
             None => {
-                let maybe_sig = result.status.signal();
+                let maybe_sig = status.signal();
                 if let Some(signal) = maybe_sig {
                     log::warn!("SymCC received signal {}", signal);
                 }
@@ -538,6 +926,16 @@ impl SymCC {
             }
         };
 
+        // The ring buffer survives the target, so we get the last test cases
+        // even if it was killed.
+        SymCC::stream_testcases(
+            &mut ring,
+            &parent,
+            output_dir.as_ref(),
+            &mut streamed,
+            &mut handle_testcase,
+        )?;
+
         let new_tests = fs::read_dir(&output_dir)
             .with_context(|| {
                 format!(
@@ -554,18 +952,35 @@ impl SymCC {
             })?
             .iter()
             .map(|entry| entry.path())
-            .collect();
+            .filter(|path| !streamed.contains(path))
+            .collect::<Vec<_>>();
 
-        let solver_time = SymCC::parse_solver_time(result.stderr);
+        for test in &new_tests {
+            if let Some(full) = materialize_testcase(test, &parent)? {
+                handle_testcase(&full)?;
+            }
+        }
+
+        let log = log_reader
+            .join()
+            .expect("The thread reading SymCC's log panicked")
+            .context("Failed to read the log of SymCC")?;
+        let runtime_stats = fs::read_to_string(&self.stats_file)
+            .ok()
+            .and_then(|data| RuntimeStats::parse(&data));
+        let solver_time = match runtime_stats.as_ref().and_then(RuntimeStats::solver_time) {
+            Some(t) => Some(t),
+            None => SymCC::parse_solver_time(log),
+        };
         if solver_time.is_some() && solver_time.unwrap() > total_time {
             log::warn!("Backend reported inaccurate solver time!");
         }
 
         Ok(SymCCResult {
-            test_cases: new_tests,
             killed,
             time: total_time,
             solver_time: solver_time.map(|t| cmp::min(t, total_time)),
+            runtime_stats,
         })
     }
 }
@@ -603,6 +1018,134 @@ mod tests {
         );
     }
 
+    #[test]
+    fn test_testcase_origin() {
+        assert_eq!(
+            testcase_id("id:000042,src:000007,time:123,op:havoc,rep:2"),
+            Some("000042")
+        );
+        assert_eq!(testcase_id("README.txt"), None);
+
+        assert_eq!(
+            testcase_origin("id:000042,src:000007,time:123,op:havoc,rep:2"),
+            Some(TestcaseOrigin::Local("000007"))
+        );
+        assert_eq!(
+            testcase_origin("id:000043,src:000007+000012,op:splice,rep:4"),
+            Some(TestcaseOrigin::Local("000007"))
+        );
+        assert_eq!(
+            testcase_origin("id:000044,sync:symcc,src:000003"),
+            Some(TestcaseOrigin::Synced {
+                fuzzer: "symcc",
+                id: "000003"
+            })
+        );
+        assert_eq!(testcase_origin("id:000000,time:0,orig:seed"), None);
+    }
+
+    #[test]
+    fn test_patch_application() {
+        let mut patch = 6u64.to_le_bytes().to_vec();
+        patch.extend_from_slice(&1u64.to_le_bytes());
+        patch.extend_from_slice(&2u32.to_le_bytes());
+        patch.extend_from_slice(b"xy");
+        patch.extend_from_slice(&5u64.to_le_bytes());
+        patch.extend_from_slice(&1u32.to_le_bytes());
+        patch.extend_from_slice(b"z");
+
+        assert_eq!(apply_patch(&patch, b"abcd").unwrap(), b"axyd\0z".to_vec());
+        assert!(apply_patch(&patch[..patch.len() - 1], b"abcd").is_err());
+
+        // Records must stay within the test case.
+        let mut patch = 2u64.to_le_bytes().to_vec();
+        patch.extend_from_slice(&1u64.to_le_bytes());
+        patch.extend_from_slice(&2u32.to_le_bytes());
+        patch.extend_from_slice(b"xy");
+        assert!(apply_patch(&patch, b"abcd").is_err());
+
+        // Corrupt lengths don't make us allocate arbitrary amounts of memory.
+        assert!(apply_patch(&u64::MAX.to_le_bytes(), b"abcd").is_err());
+    }
+
+    #[test]
+    fn test_testcase_materialization() {
+        let dir = tempfile::tempdir().unwrap();
+
+        // Only the file name marks patches, so full test cases may contain
+        // anything.
+        let full = dir.path().join("000000");
+        fs::write(&full, b"SYMPATCH").unwrap();
+        assert_eq!(
+            materialize_testcase(&full, b"abcd").unwrap(),
+            Some(full.clone())
+        );
+        assert_eq!(fs::read(&full).unwrap(), b"SYMPATCH");
+
+        let patch = dir.path().join("000001.patch");
+        let mut data = 4u64.to_le_bytes().to_vec();
+        data.extend_from_slice(&1u64.to_le_bytes());
+        data.extend_from_slice(&1u32.to_le_bytes());
+        data.extend_from_slice(b"x");
+        fs::write(&patch, &data).unwrap();
+        let patched = dir.path().join("000001");
+        assert_eq!(
+            materialize_testcase(&patch, b"abcd").unwrap(),
+            Some(patched.clone())
+        );
+        assert_eq!(fs::read(&patched).unwrap(), b"axcd");
+        assert!(!patch.exists());
+
+        let broken = dir.path().join("000002.patch");
+        fs::write(&broken, &data[..data.len() - 1]).unwrap();
+        assert_eq!(materialize_testcase(&broken, b"abcd").unwrap(), None);
+    }
+
+    #[test]
+    fn test_corrupt_ring() {
+        use std::fs::OpenOptions;
+        use std::os::unix::fs::FileExt;
+
+        let dir = tempfile::tempdir().unwrap();
+        let ring = TestcaseRing::new(16).unwrap();
+        // Make the head (at offset 16) claim that the backend has written more
+        // than the ring can hold.
+        OpenOptions::new()
+            .write(true)
+            .open(ring.path())
+            .unwrap()
+            .write_all_at(&100u64.to_le_bytes(), 16)
+            .unwrap();
+
+        let mut ring = Some(ring);
+        let mut handled = 0;
+        SymCC::stream_testcases(&mut ring, b"", dir.path(), &mut HashSet::new(), &mut |_| {
+            handled += 1;
+            Ok(())
+        })
+        .unwrap();
+        assert!(ring.is_none());
+        assert_eq!(handled, 0);
+    }
+
+    #[test]
+    fn test_runtime_stats_parsing() {
+        let stats = RuntimeStats::parse(
+            r#"{"solver_time_us": 1500, "queries": 3, "build_add": 42,
+                "peak_expression_bytes": 4096}"#,
+        )
+        .unwrap();
+        assert_eq!(stats.counters.len(), 4);
+        assert_eq!(stats.counters["build_add"], 42);
+        assert_eq!(stats.solver_time(), Some(Duration::from_micros(1500)));
+
+        let stats = RuntimeStats::parse(r#"{"queries": 0}"#).unwrap();
+        assert_eq!(stats.solver_time(), None);
+
+        assert_eq!(RuntimeStats::parse("{}"), None);
+        assert_eq!(RuntimeStats::parse("garbage"), None);
+    }
+
     #[test]
     fn test_solver_time_parsing() {
         let output = r#"[INFO] New testcase: /tmp/output/000005